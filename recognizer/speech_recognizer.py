@@ -4,8 +4,11 @@ import queue
 import vosk
 import sys
 import json
+import socket
+import struct
 import threading
 import time
+from collections import deque
 import numpy as np
 
 import pyaudio
@@ -22,16 +25,159 @@ CLR_YELLOW = "\033[38;2;255;255;0m"
 audio_queue = queue.Queue(maxsize=8)  # bounded to avoid unbounded lag if processing stalls
 trigger_words = set()
 recognized_word = None
-subtitle_pipe_path = "/tmp/visor_subtitles"
-pipe_path = "/tmp/visor_pipe"
-spectrum_pipe_path = "/tmp/visor_spectrum"
-
-# Store open file descriptors for inter-process communication pipes
-pipe_handles = {
-    "pipe": None,
-    "subtitle": None,
-    "spectrum": None,
+socket_path = "/tmp/visor.sock"
+
+# Message types of the framed HUD protocol (see src/message_handler.h)
+MSG_KEYWORD = 1
+MSG_PARTIAL = 2
+MSG_FINAL = 3
+MSG_SPECTRUM = 4
+MSG_CONTROL = 5
+MSG_NAMES = {MSG_KEYWORD: "keyword", MSG_PARTIAL: "partial", MSG_FINAL: "final",
+             MSG_SPECTRUM: "spectrum", MSG_CONTROL: "control"}
+
+# Frame header: uint32 length, uint8 type, int64 capture/process/sent ns (little-endian)
+FRAME_HEADER = struct.Struct("<IBqqq")
+MAX_FRAME_LENGTH = 64 * 1024
+MAX_OUTBOX_BYTES = 256 * 1024  # unsent bytes tolerated before dropping messages
+RECONNECT_INTERVAL = 0.5
+STATS_INTERVAL = 5.0
+
+# Connection to the HUD; messages the socket could not take yet wait in the outbox
+link = {
+    "sock": None,
+    "outbox": deque(),
+    "outbox_bytes": 0,
+    "head_offset": 0,
+    "last_attempt": 0.0,
+    "connect_error_logged": False,
+    "connected_before": False,
+    "reconnects": 0,  # connects after a dropped link, not the first one
+    "sent": {t: 0 for t in MSG_NAMES},
+    "dropped": {t: 0 for t in MSG_NAMES},
 }
+link_lock = threading.Lock()
+
+# CLOCK_MONOTONIC nanoseconds, the same clock the HUD stamps with
+def monotonic_ns():
+    return time.clock_gettime_ns(time.CLOCK_MONOTONIC)
+
+# Connects to the HUD socket without blocking, at most once per RECONNECT_INTERVAL.
+# Only called from the main loop so the recognition worker never waits on it.
+def connect_link():
+    now = time.monotonic()
+    if now - link["last_attempt"] < RECONNECT_INTERVAL:
+        return False
+    link["last_attempt"] = now
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.setblocking(False)
+    try:
+        sock.connect(socket_path)
+    except BlockingIOError:
+        # EAGAIN/EINPROGRESS: HUD backlog is full, retry on a later tick
+        sock.close()
+        return False
+    except OSError as e:
+        sock.close()
+        if not link["connect_error_logged"]:
+            print(f"{CLR_YELLOW}[PY] :: [HUD L1NK D0WN] >> {e}{CLR_RESET}", file=sys.stderr)
+            link["connect_error_logged"] = True
+        return False
+    link["sock"] = sock
+    link["connect_error_logged"] = False
+    if link["connected_before"]:
+        link["reconnects"] += 1
+    link["connected_before"] = True
+    print(f"{CLR_CYAN}[PY] :: [HUD L1NK ESTABL1SH3D]{CLR_RESET}")
+    return True
+
+# Closes the socket; queued frames are stale by the time we reconnect
+def disconnect_link(reason):
+    print(f"{CLR_YELLOW}[PY] :: [HUD L1NK L0ST] >> {reason}{CLR_RESET}", file=sys.stderr)
+    link["sock"].close()
+    link["sock"] = None
+    for msg_type, _ in link["outbox"]:
+        link["dropped"][msg_type] += 1
+    link["outbox"].clear()
+    link["outbox_bytes"] = 0
+    link["head_offset"] = 0
+
+# Writes as much of the outbox as the socket accepts without blocking
+def flush_link():
+    while link["outbox"]:
+        msg_type, frame = link["outbox"][0]
+        try:
+            sent = link["sock"].send(memoryview(frame)[link["head_offset"]:])
+        except BlockingIOError:
+            return
+        except OSError as e:
+            disconnect_link(e)
+            return
+        link["head_offset"] += sent
+        if link["head_offset"] == len(frame):
+            link["outbox"].popleft()
+            link["outbox_bytes"] -= len(frame)
+            link["head_offset"] = 0
+            link["sent"][msg_type] += 1
+
+# Cuts UTF-8 bytes to at most limit without splitting a multi-byte character
+def truncate_utf8(data, limit):
+    if len(data) <= limit:
+        return data
+    cut = limit
+    while cut > 0 and (data[cut] & 0xC0) == 0x80:  # continuation byte
+        cut -= 1
+    return data[:cut]
+
+# Frames a message with its latency stamps and queues it for the HUD.
+# Backpressure: after flushing, spectra are dropped if the HUD is still
+# behind, everything else only once the outbox is full.
+def send_message(msg_type, stamps, payload):
+    capture_ns, process_ns = stamps
+    max_payload = MAX_FRAME_LENGTH - (FRAME_HEADER.size - 4)
+    if msg_type == MSG_SPECTRUM:
+        payload = payload[:max_payload - max_payload % 4]
+    else:
+        payload = truncate_utf8(payload, max_payload)
+    frame = FRAME_HEADER.pack(FRAME_HEADER.size - 4 + len(payload), msg_type,
+                              capture_ns, process_ns, monotonic_ns()) + payload
+    with link_lock:
+        if link["sock"] is None:
+            link["dropped"][msg_type] += 1
+            return
+        flush_link()
+        if link["sock"] is None:
+            link["dropped"][msg_type] += 1
+            return
+        if link["outbox"] and (msg_type == MSG_SPECTRUM or
+                               link["outbox_bytes"] + len(frame) > MAX_OUTBOX_BYTES):
+            link["dropped"][msg_type] += 1
+            return
+        link["outbox"].append((msg_type, frame))
+        link["outbox_bytes"] += len(frame)
+        flush_link()
+
+# Reconnects and flushes queued frames from the main loop, so a frame stuck
+# behind EAGAIN goes out once the HUD drains, not when the next message arrives
+def service_link():
+    with link_lock:
+        if link["sock"] is None:
+            connect_link()
+        else:
+            flush_link()
+
+# Reports drop counters to the HUD as a control message when they change
+def report_link_stats(last_report):
+    # Snapshot under the lock; the worker updates these counters
+    with link_lock:
+        dropped_by_type = dict(link["dropped"])
+        reconnects = link["reconnects"]
+    dropped = sum(dropped_by_type.values())
+    if dropped == last_report:
+        return last_report
+    summary = " ".join(f"{MSG_NAMES[t]}={n}" for t, n in dropped_by_type.items() if n)
+    send_message(MSG_CONTROL, (0, 0), f"tx dropped {summary} reconnects={reconnects}".encode())
+    return dropped
 
 # Loads trigger keywords from animation directory names
 def load_trigger_words(directory="animations"):
@@ -42,71 +188,48 @@ def load_trigger_words(directory="animations"):
     except Exception as e:
         print(f"[Python] Failed to load trigger words: {e}", file=sys.stderr)
 
-# Sends detected trigger word to the animation control pipe
-def send_to_pipe(word):
-    try:
-        if pipe_handles["pipe"] is None:
-            fd = os.open(pipe_path, os.O_WRONLY | os.O_NONBLOCK)
-            pipe_handles["pipe"] = os.fdopen(fd, "w")
-        pipe_handles["pipe"].write(word + "\n")
-        pipe_handles["pipe"].flush()
-    except Exception as e:
-        pipe_handles["pipe"] = None
-        print(f"{CLR_YELLOW}[PY] :: [PIPE WRI7E ERR] >> {e}{CLR_RESET}", file=sys.stderr)
+# Sends detected trigger word to the HUD
+def send_keyword(word, stamps):
+    send_message(MSG_KEYWORD, stamps, word.encode("utf-8"))
 
-# Sends recognized speech text to the subtitle pipe
-def send_subtitle(text):
-    try:
-        if pipe_handles["subtitle"] is None:
-            fd = os.open(subtitle_pipe_path, os.O_WRONLY | os.O_NONBLOCK)
-            pipe_handles["subtitle"] = os.fdopen(fd, "w")
-        pipe_handles["subtitle"].write(text + "\n")
-        pipe_handles["subtitle"].flush()
-    except Exception as e:
-        pipe_handles["subtitle"] = None
-        print(f"{CLR_YELLOW}[PY] :: [SUBTITLE PIPE ERR] >> {e}{CLR_RESET}", file=sys.stderr)
+# Sends recognized speech text to the HUD (partial or final result)
+def send_subtitle(text, msg_type, stamps):
+    send_message(msg_type, stamps, text.encode("utf-8"))
 
-# Sends real-time FFT spectrum data to the spectrum pipe
-def send_spectrum(freq_data):
-    try:
-        if pipe_handles["spectrum"] is None:
-            fd = os.open(spectrum_pipe_path, os.O_WRONLY | os.O_NONBLOCK)
-            pipe_handles["spectrum"] = os.fdopen(fd, "w")
-        pipe_handles["spectrum"].write(",".join(f"{x:.4f}" for x in freq_data) + "\n")
-        pipe_handles["spectrum"].flush()
-    except Exception as e:
-        pipe_handles["spectrum"] = None
-        print(f"{CLR_YELLOW}[PY] :: [SPECTRUM PIPE ERR] >> {e}{CLR_RESET}", file=sys.stderr)
+# Sends real-time FFT spectrum data to the HUD as float32 values
+def send_spectrum(freq_data, stamps):
+    send_message(MSG_SPECTRUM, stamps, np.asarray(freq_data, dtype="<f4").tobytes())
 
 # Run recognition + spectrum in a worker to keep the audio callback lightweight
 def processing_worker(recognizer):
     while True:
         try:
-            in_data = audio_queue.get(timeout=1)
+            capture_ns, in_data = audio_queue.get(timeout=1)
         except queue.Empty:
             continue
+        stamps = (capture_ns, monotonic_ns())
 
         # Spectrum
         samples = np.frombuffer(in_data, dtype=np.int16).astype(np.float32) / 32768.0
         fft = np.abs(np.fft.rfft(samples, n=128))[:64]
         fft = np.clip(fft / np.max(fft), 0, 1) if np.max(fft) != 0 else fft
-        send_spectrum(fft)
+        send_spectrum(fft, stamps)
 
         # Speech recognition section
         if recognizer.AcceptWaveform(in_data):
             result = json.loads(recognizer.Result())
             text = result.get("text", "")
-            send_subtitle(text)
+            send_subtitle(text, MSG_FINAL, stamps)
             for word in text.split():
                 if word in trigger_words:
                     print(f"{CLR_GREEN}[PY] :: [K3YWORD DETECT3D] >> {word}{CLR_RESET}")
-                    send_to_pipe(word)
+                    send_keyword(word, stamps)
                     break
         else:
             partial = json.loads(recognizer.PartialResult())
             partial_text = partial.get("partial", "")
             if partial_text:
-                send_subtitle(partial_text)
+                send_subtitle(partial_text, MSG_PARTIAL, stamps)
 
 
 # Initializes audio input/output stream with lightweight callback for low latency
@@ -119,11 +242,13 @@ def start_streaming_audio(recognizer):
 
     def callback(in_data, frame_count, time_info, status):
         nonlocal phase
+        # Stamp when the block's first sample was captured (callback fires once the block is full)
+        capture_ns = monotonic_ns() - frame_count * 1_000_000_000 // input_rate
         # Keep queue bounded to avoid runaway latency
         try:
             while audio_queue.full():
                 audio_queue.get_nowait()
-            audio_queue.put_nowait(in_data)
+            audio_queue.put_nowait((capture_ns, in_data))
         except queue.Full:
             pass
 
@@ -150,22 +275,24 @@ def start_streaming_audio(recognizer):
     threading.Thread(target=processing_worker, args=(recognizer,), daemon=True).start()
     return stream
 
-# Main loop that sets up pipes, loads model, and starts the audio processing loop
+# Main loop that loads model, starts the audio processing loop and reports link stats
 def main():
-    if not os.path.exists(pipe_path):
-        os.mkfifo(pipe_path)
-    if not os.path.exists(spectrum_pipe_path):
-        os.mkfifo(spectrum_pipe_path)
-
     load_trigger_words("animations")
 
     model = vosk.Model("model")
     recognizer = vosk.KaldiRecognizer(model, 16000)
+    service_link()  # connect before the first results are sent
     stream = start_streaming_audio(recognizer)
     print(f"{CLR_PURPLE}[PY] :: [L1ST3N1NG W1TH R0B0-V0C0D3R]{CLR_RESET}")
+    last_report = 0
+    last_stats = time.monotonic()
     try:
         while True:
             time.sleep(0.1)
+            service_link()
+            if time.monotonic() - last_stats >= STATS_INTERVAL:
+                last_stats = time.monotonic()
+                last_report = report_link_stats(last_report)
     except KeyboardInterrupt:
         print(f"\n{CLR_PINK}[PY] :: [D3T4CH1NG . . . G00DBY3]{CLR_RESET}")
         sys.exit(0)
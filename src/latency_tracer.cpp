@@ -0,0 +1,170 @@
+#include "latency_tracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+// Bounds so a long session cannot grow without limit. Trace records stop at
+// the cap (evicting single records would orphan async begin/end pairs);
+// latency samples drop their oldest entries.
+// 48-byte records, so the cap is about 10 MB. At ~15.6 spectrum events/s
+// (12 records each) plus 3 records per frame, that is ~270 records/s when
+// silent and ~460/s while speaking: roughly 7-12 minutes of trace.
+constexpr size_t kMaxRecords = 200000;
+constexpr size_t kRecordsPerFrame = 3;
+constexpr size_t kRecordsPerEvent = 12;
+constexpr size_t kMaxSamplesPerType = 20000;
+
+// Chrome trace process ids
+constexpr int kPidEvents = 1;  // one async track per message, capture -> photon
+constexpr int kPidHud = 2;     // per-frame receive/render/present spans
+
+std::string jsonEscape(const char* s) {
+    std::string out;
+    for (; *s; ++s) {
+        char c = *s;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+// Nearest-rank percentile of an ascending sorted vector
+int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    rank = std::clamp<size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
+}
+}
+
+LatencyTracer::LatencyTracer(bool enabled) : active(enabled) {}
+
+int64_t LatencyTracer::nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void LatencyTracer::eventReceived(const char* type, const Stamps& stamps, int64_t receivedNs) {
+    if (!active || !stamps.valid()) return;
+    pending.push_back({type, stamps, receivedNs});
+}
+
+void LatencyTracer::framePresented(int64_t receiveStartNs, int64_t renderStartNs,
+                                   int64_t presentStartNs, int64_t presentEndNs) {
+    if (!active) return;
+    // A frame's spans are kept or dropped together
+    if (reserveRecords(kRecordsPerFrame)) {
+        pushRecord({"receive", "hud", 'X', kPidHud, 0, receiveStartNs, renderStartNs - receiveStartNs});
+        pushRecord({"render", "hud", 'X', kPidHud, 0, renderStartNs, presentStartNs - renderStartNs});
+        pushRecord({"present", "hud", 'X', kPidHud, 0, presentStartNs, presentEndNs - presentStartNs});
+    }
+
+    for (const auto& ev : pending) {
+        const Stamps& s = ev.stamps;
+        auto& samples = latencies[ev.type];
+        samples.push_back(presentEndNs - s.captureNs);
+        if (samples.size() > kMaxSamplesPerType) samples.pop_front();
+
+        // All of an event's spans are kept or dropped together
+        if (!reserveRecords(kRecordsPerEvent)) continue;
+        uint64_t id = nextEventId++;
+        pushAsyncSpan(ev.type, ev.type, kPidEvents, id, s.captureNs, presentEndNs);
+        pushAsyncSpan("buffer+queue", ev.type, kPidEvents, id, s.captureNs, s.processNs);
+        pushAsyncSpan("recognize", ev.type, kPidEvents, id, s.processNs, s.sentNs);
+        pushAsyncSpan("ipc", ev.type, kPidEvents, id, s.sentNs, ev.receivedNs);
+        pushAsyncSpan("render", ev.type, kPidEvents, id, ev.receivedNs, presentStartNs);
+        pushAsyncSpan("present", ev.type, kPidEvents, id, presentStartNs, presentEndNs);
+    }
+    pending.clear();
+}
+
+bool LatencyTracer::reserveRecords(size_t count) {
+    if (records.size() + count > kMaxRecords) {
+        droppedRecords += count;
+        return false;
+    }
+    return true;
+}
+
+void LatencyTracer::pushRecord(TraceRecord record) {
+    records.push_back(std::move(record));
+}
+
+void LatencyTracer::pushAsyncSpan(const char* name, const char* cat, int pid,
+                                  uint64_t id, int64_t startNs, int64_t endNs) {
+    pushRecord({name, cat, 'b', pid, id, startNs, 0});
+    pushRecord({name, cat, 'e', pid, id, endNs, 0});
+}
+
+bool LatencyTracer::exportChromeTrace(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "[LatencyTracer] Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << kPidEvents
+        << ",\"tid\":0,\"args\":{\"name\":\"capture->photon\"}},\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << kPidHud
+        << ",\"tid\":0,\"args\":{\"name\":\"hud\"}}";
+
+    for (const auto& r : records) {
+        out << ",\n{\"name\":\"" << jsonEscape(r.name) << "\",\"cat\":\"" << jsonEscape(r.cat)
+            << "\",\"ph\":\"" << r.phase << "\",\"pid\":" << r.pid << ",\"tid\":1"
+            << ",\"ts\":" << r.tsNs / 1000.0;
+        if (r.phase == 'X') {
+            out << ",\"dur\":" << r.durNs / 1000.0;
+        } else {
+            out << ",\"id\":" << r.id;
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+
+    std::cout << "[LatencyTracer] Wrote " << records.size() << " trace events to " << path;
+    if (droppedRecords > 0) std::cout << " (" << droppedRecords << " dropped after the cap)";
+    std::cout << std::endl;
+    return static_cast<bool>(out);
+}
+
+void LatencyTracer::printSummary(std::ostream& out) const {
+    out << "[LatencyTracer] capture->photon latency (ms)" << std::endl;
+    if (latencies.empty()) {
+        out << "[LatencyTracer]   no stamped events received" << std::endl;
+        return;
+    }
+
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& [type, samples] : latencies) {
+        std::vector<int64_t> sorted(samples.begin(), samples.end());
+        std::sort(sorted.begin(), sorted.end());
+        out << "[LatencyTracer]   " << std::left << std::setw(9) << type << std::right
+            << " n=" << sorted.size()
+            << " p50=" << percentile(sorted, 50) / 1e6
+            << " p90=" << percentile(sorted, 90) / 1e6
+            << " p99=" << percentile(sorted, 99) / 1e6
+            << " max=" << sorted.back() / 1e6 << std::endl;
+    }
+    out.flags(flags);
+}
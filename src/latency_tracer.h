@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Cross-process latency tracing from audio capture to presented frame.
+// All timestamps are CLOCK_MONOTONIC nanoseconds so stamps taken by the
+// Python recognizer line up with stamps taken here.
+// Opt-in (records nothing when disabled) and only used from the main loop
+// thread, so no locking. Span names and event types must be string
+// literals; records keep the pointers.
+class LatencyTracer {
+public:
+    // Stamps carried with every message from the recognizer
+    struct Stamps {
+        int64_t captureNs = 0;  // first sample of the audio block captured
+        int64_t processNs = 0;  // block dequeued by the recognizer worker
+        int64_t sentNs = 0;     // message written to the IPC channel
+
+        bool valid() const { return captureNs > 0 && processNs >= captureNs && sentNs >= processNs; }
+    };
+
+    explicit LatencyTracer(bool enabled);
+
+    bool enabled() const { return active; }
+
+    // Current CLOCK_MONOTONIC time in nanoseconds
+    static int64_t nowNs();
+
+    // A stamped message was received this frame; completes on framePresented()
+    void eventReceived(const char* type, const Stamps& stamps, int64_t receivedNs);
+
+    // The frame showing every event received since the last call is on screen;
+    // records its receive/render/present spans on the HUD track
+    void framePresented(int64_t receiveStartNs, int64_t renderStartNs,
+                        int64_t presentStartNs, int64_t presentEndNs);
+
+    // Write everything recorded as Chrome trace-event JSON (chrome://tracing, Perfetto)
+    bool exportChromeTrace(const std::string& path) const;
+
+    // Print capture->photon latency percentiles per event type
+    void printSummary(std::ostream& out) const;
+
+private:
+    struct PendingEvent {
+        const char* type;
+        Stamps stamps;
+        int64_t receivedNs;
+    };
+
+    struct TraceRecord {
+        const char* name;
+        const char* cat;
+        char phase;     // 'X' complete, 'b'/'e' async begin/end
+        int pid;
+        uint64_t id;    // async id (0 for complete events)
+        int64_t tsNs;
+        int64_t durNs;  // only for complete events
+    };
+
+    // False (and counted as dropped) if count more records would pass the cap
+    bool reserveRecords(size_t count);
+    void pushRecord(TraceRecord record);
+    void pushAsyncSpan(const char* name, const char* cat, int pid,
+                       uint64_t id, int64_t startNs, int64_t endNs);
+
+    bool active;
+    std::vector<PendingEvent> pending;
+    std::deque<TraceRecord> records;
+    std::map<std::string, std::deque<int64_t>> latencies;  // capture->photon per type
+    uint64_t nextEventId = 1;
+    uint64_t droppedRecords = 0;
+};
@@ -11,10 +11,9 @@
 #include <thread>
 #include <chrono>
 #include <future>
-#include <fcntl.h>   // open
+#include <fcntl.h>   // fcntl
 #include <unistd.h>  // read
-#include <cstring>   // strerror
-#include <sys/stat.h>
+#include <cstdlib>   // getenv
 #include <termios.h>
 #include <sys/ioctl.h>
 #include <vector>
@@ -29,6 +28,7 @@
 #include "animation_manager.h"
 #include "message_handler.h"
 #include "control_interface.h"
+#include "latency_tracer.h"
 
 using Clock = std::chrono::steady_clock;
 
@@ -141,6 +141,12 @@ int main() {
     AnimationManager animationManager;
     animationManager.loadAnimations("animations");
 
+    // Listen for the recognizer before launching it so its first connect succeeds
+    MessageHandler messageHandler("/tmp/visor.sock");
+    if (!messageHandler.start()) {
+        return 1;
+    }
+
     // Launch Python recognizer
     std::cout << CLR_CYAN << "[Main] :: [Launching $peech L1$ten3r . . .]" << CLR_RESET << std::endl;
     // Play startup sound (non-blocking)
@@ -155,38 +161,14 @@ int main() {
     // Store the Python process ID globally
     pythonPid = pid;
 
-    // Open named pipe (FIFO)
-    const char* pipePath = "/tmp/visor_pipe";
-    mkfifo(pipePath, 0666); // create if not already exists
-    int pipeFd = open(pipePath, O_RDONLY | O_NONBLOCK);
-    if (pipeFd == -1) {
-        std::cerr << "[Main] Failed to open pipe: " << strerror(errno) << std::endl;
-        return 1;
-    }
-
     // Global subtitle state
     std::string subtitleText;
     auto lastSubtitleTime = Clock::now();
     const std::chrono::seconds subtitleDisplayTime(5);
 
-    // Open the subtitle pipe
-    const char* subtitlePipePath = "/tmp/visor_subtitles";
-    mkfifo(subtitlePipePath, 0666);
-    int subtitleFd = open(subtitlePipePath, O_RDONLY | O_NONBLOCK);
-    if (subtitleFd == -1) {
-        std::cerr << "[Main] Failed to open subtitle pipe: " << strerror(errno) << std::endl;
-    }
-
-    // Open the spectrum pipe
-    const char* spectrumPipePath = "/tmp/visor_spectrum";
-    mkfifo(spectrumPipePath, 0666);
-    int spectrumFd = open(spectrumPipePath, O_RDONLY | O_NONBLOCK);
-    if (spectrumFd == -1) {
-        std::cerr << "[Main] Failed to open spectrum pipe: " << strerror(errno) << std::endl;
-    }
-
-
-    char buffer[256];
+    // Capture->photon latency tracing, opt-in: VISOR_TRACE=<trace.json> exports on exit
+    const char* traceOutputPath = std::getenv("VISOR_TRACE");
+    LatencyTracer latencyTracer(traceOutputPath != nullptr && *traceOutputPath != '\0');
 
     // Idle animation support
     auto lastAnimationTime = Clock::now();
@@ -255,64 +237,57 @@ int main() {
 
     static size_t currentLine = 0; // Tracks current subtitle line being rendered
 
+    // Audio spectrum from the recognizer's FFT
+    float spectrum[64] = {0};
+
     // Main event loop
     while (keepRunning.load()) {
-        ssize_t bytesRead = read(pipeFd, buffer, sizeof(buffer) - 1);
-        if (bytesRead > 0) {
-            buffer[bytesRead] = '\0';  // null-terminate
-            std::string keyword(buffer);
-            keyword.erase(keyword.find_last_not_of(" \n\r\t") + 1);  // trim trailing whitespace
-
-            std::cout << CLR_GREEN << "[Main] :: [K3YWORD ACQUIRED] >> " << keyword << CLR_RESET << std::endl;
-            animationManager.playAnimation(keyword);
-            lastAnimationTime = Clock::now();
-            // Reset glitch timing if user activity detected
-            currentMessageInterval = baseMessageInterval;
-        }
-
-        // Read subtitle pipe
-        char subtitleBuf[512];
-        ssize_t subRead = read(subtitleFd, subtitleBuf, sizeof(subtitleBuf) - 1);
-        if (subRead > 0) {
-            subtitleBuf[subRead] = '\0';
-            std::string newText = std::string(subtitleBuf);
-            newText.erase(newText.find_last_not_of(" \n\r\t") + 1);
-            static std::string lastSubtitleText;
-            if (newText != subtitleText) {
-                subtitleText = newText;
-                lastSubtitleText = newText;
-                lastSubtitleTime = Clock::now();
-                currentLine = 0; // Reset line animation when subtitle changes
-                // Reset glitch timer and interval progression to initial state when subtitle arrives
-                currentGlitchStage = 0;
-                glitchInterval = glitchIntervals[currentGlitchStage];
-                lastGlitchSpawn = Clock::now();
+        int64_t frameStartNs = LatencyTracer::nowNs();
+
+        // Drain every message the recognizer sent since the last frame
+        bool spectrumUpdated = false;
+        for (const auto& msg : messageHandler.poll()) {
+            latencyTracer.eventReceived(messageTypeName(msg.type), msg.stamps, LatencyTracer::nowNs());
+            switch (msg.type) {
+                case MessageType::Keyword:
+                    std::cout << CLR_GREEN << "[Main] :: [K3YWORD ACQUIRED] >> " << msg.text << CLR_RESET << std::endl;
+                    animationManager.playAnimation(msg.text);
+                    lastAnimationTime = Clock::now();
+                    // Reset glitch timing if user activity detected
+                    currentMessageInterval = baseMessageInterval;
+                    break;
+                case MessageType::Partial:
+                case MessageType::Final:
+                    if (msg.text != subtitleText) {
+                        subtitleText = msg.text;
+                        lastSubtitleTime = Clock::now();
+                        currentLine = 0; // Reset line animation when subtitle changes
+                        // Reset glitch timer and interval progression to initial state when subtitle arrives
+                        currentGlitchStage = 0;
+                        glitchInterval = glitchIntervals[currentGlitchStage];
+                        lastGlitchSpawn = Clock::now();
+                    }
+                    break;
+                case MessageType::Spectrum:
+                    for (int i = 0; i < 64; ++i) {
+                        spectrum[i] = i < static_cast<int>(msg.spectrum.size()) ? msg.spectrum[i] : 0.0f;
+                    }
+                    spectrumUpdated = true;
+                    break;
+                case MessageType::Control:
+                    std::cout << CLR_CYAN << "[Main] :: [R3COGN1Z3R] >> " << msg.text << CLR_RESET << std::endl;
+                    break;
             }
         }
 
+        int64_t renderStartNs = LatencyTracer::nowNs();
+
         // --- Draw order: clear, spectrum, then subtitles, then glitches ---
         // 1. Clear the frame to black each frame before drawing
         frame.setTo(cv::Scalar(0, 0, 0));
 
-        // 2. Prepare audio spectrum buffer for FFT integration
-        static float spectrum[64] = {0};
-        char spectrumBuf[1024];
-        ssize_t spectrumRead = read(spectrumFd, spectrumBuf, sizeof(spectrumBuf) - 1);
-        if (spectrumRead > 0) {
-            spectrumBuf[spectrumRead] = '\0';
-            std::istringstream iss(spectrumBuf);
-            std::string token;
-            int idx = 0;
-            while (std::getline(iss, token, ',') && idx < 64) {
-                try {
-                    spectrum[idx] = std::stof(token);
-                } catch (...) {
-                    spectrum[idx] = 0.0f;
-                }
-                ++idx;
-            }
-        } else if (spectrumRead <= 0) {
-            // If no new spectrum data, decay the spectrum slowly
+        // 2. If no new spectrum data, decay the spectrum slowly
+        if (!spectrumUpdated) {
             for (int i = 0; i < 64; ++i) {
                 spectrum[i] *= 0.9f;
             }
@@ -472,8 +447,10 @@ int main() {
         }
 
         // Show frame and handle key input after all drawing
+        int64_t presentStartNs = LatencyTracer::nowNs();
         cv::imshow("SubtitleOverlay", frame);
         int key = cv::waitKey(1);
+        latencyTracer.framePresented(frameStartNs, renderStartNs, presentStartNs, LatencyTracer::nowNs());
         // Handle quit and numeric-key sound effects via the OpenCV window
         switch (key) {
             case 'q': case 'Q':
@@ -565,12 +542,11 @@ int main() {
     cv::destroyWindow("SubtitleOverlay");
 
     std::cout << CLR_CYAN << "[Main] :: [SYS.EXI7() ~ cleaning up . . .]" << CLR_RESET << std::endl;
-    close(pipeFd);
-    unlink(pipePath);  // optional cleanup
-    close(subtitleFd);
-    unlink(subtitlePipePath);
-    close(spectrumFd);
-    unlink(spectrumPipePath);
+    messageHandler.printStats(std::cout);
+    if (latencyTracer.enabled()) {
+        latencyTracer.exportChromeTrace(traceOutputPath);
+        latencyTracer.printSummary(std::cout);
+    }
 
     // Cleanly terminate Python recognizer with timeout, then force if needed
     if (pythonPid > 0) {
@@ -0,0 +1,238 @@
+#include "message_handler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+// Upper bound on bytes read per poll() so a flood cannot stall a frame
+constexpr size_t kMaxBytesPerPoll = 1024 * 1024;
+
+uint32_t readU32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+int64_t readI64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return static_cast<int64_t>(v);
+}
+
+bool knownType(uint8_t type) {
+    return type >= static_cast<uint8_t>(MessageType::Keyword) &&
+           type <= static_cast<uint8_t>(MessageType::Control);
+}
+}
+
+const char* messageTypeName(MessageType type) {
+    switch (type) {
+        case MessageType::Keyword: return "keyword";
+        case MessageType::Partial: return "partial";
+        case MessageType::Final: return "final";
+        case MessageType::Spectrum: return "spectrum";
+        case MessageType::Control: return "control";
+    }
+    return "unknown";
+}
+
+void MessageDecoder::feed(const char* data, size_t len) {
+    buffer.append(data, len);
+}
+
+bool MessageDecoder::next(VisorMessage& msg) {
+    while (!corrupt) {
+        if (buffered() < 4) return false;
+        const auto* p = reinterpret_cast<const unsigned char*>(buffer.data()) + offset;
+        uint32_t length = readU32(p);
+        if (length < kHeaderSize - 4 || length > kMaxFrameLength) {
+            corrupt = true;
+            return false;
+        }
+        if (buffered() < 4 + static_cast<size_t>(length)) return false;
+
+        uint8_t type = p[4];
+        const unsigned char* payload = p + kHeaderSize;
+        size_t payloadLen = length - (kHeaderSize - 4);
+        offset += 4 + length;
+
+        bool decoded = false;
+        if (knownType(type)) {
+            msg.type = static_cast<MessageType>(type);
+            msg.stamps.captureNs = readI64(p + 5);
+            msg.stamps.processNs = readI64(p + 13);
+            msg.stamps.sentNs = readI64(p + 21);
+            msg.text.clear();
+            msg.spectrum.clear();
+            if (msg.type == MessageType::Spectrum) {
+                msg.spectrum.resize(payloadLen / 4);
+                for (size_t i = 0; i < msg.spectrum.size(); ++i) {
+                    uint32_t bits = readU32(payload + i * 4);
+                    std::memcpy(&msg.spectrum[i], &bits, sizeof(float));
+                }
+            } else {
+                msg.text.assign(reinterpret_cast<const char*>(payload), payloadLen);
+            }
+            decoded = true;
+        } else {
+            skippedUnknown++;
+        }
+
+        // Compact once the consumed prefix dominates the buffer
+        if (offset == buffer.size()) {
+            buffer.clear();
+            offset = 0;
+        } else if (offset > buffer.size() / 2) {
+            buffer.erase(0, offset);
+            offset = 0;
+        }
+        if (decoded) return true;
+    }
+    return false;
+}
+
+void MessageDecoder::reset() {
+    buffer.clear();
+    offset = 0;
+    corrupt = false;
+}
+
+MessageHandler::MessageHandler(const std::string& socketPath) : path(socketPath) {}
+
+MessageHandler::~MessageHandler() {
+    if (clientFd != -1) close(clientFd);
+    if (listenFd != -1) {
+        close(listenFd);
+        unlink(path.c_str());
+    }
+}
+
+bool MessageHandler::start() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[MessageHandler] Socket path too long: " << path << std::endl;
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd == -1) {
+        std::cerr << "[MessageHandler] Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(path.c_str());  // stale socket from a previous run
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+        listen(listenFd, 4) == -1) {
+        std::cerr << "[MessageHandler] Failed to listen on " << path << ": " << strerror(errno) << std::endl;
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void MessageHandler::acceptPending() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "[MessageHandler] Accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        // A reconnecting recognizer supersedes the old connection
+        if (clientFd != -1) dropClient("replaced by new connection");
+        clientFd = fd;
+        decoder.reset();
+        counters.connections++;
+        std::cout << "[MessageHandler] Recognizer connected" << std::endl;
+    }
+}
+
+void MessageHandler::dropClient(const char* reason) {
+    if (clientFd == -1) return;
+    std::cerr << "[MessageHandler] Dropping recognizer connection: " << reason << std::endl;
+    close(clientFd);
+    clientFd = -1;
+    decoder.reset();
+    counters.disconnects++;
+}
+
+std::vector<VisorMessage> MessageHandler::poll() {
+    std::vector<VisorMessage> messages;
+    if (listenFd == -1) return messages;
+    acceptPending();
+    if (clientFd == -1) return messages;
+
+    // Drain everything the socket has, bounded per frame
+    char buf[64 * 1024];
+    size_t total = 0;
+    const char* closeReason = nullptr;
+    while (true) {
+        if (total >= kMaxBytesPerPoll) {
+            counters.drainLimitHits++;
+            break;
+        }
+        ssize_t n = read(clientFd, buf, sizeof(buf));
+        if (n > 0) {
+            decoder.feed(buf, static_cast<size_t>(n));
+            total += static_cast<size_t>(n);
+        } else if (n == 0) {
+            closeReason = "recognizer disconnected";
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) closeReason = strerror(errno);
+            break;
+        }
+    }
+    counters.bytesReceived += total;
+
+    VisorMessage msg;
+    int latestSpectrum = -1;
+    uint64_t decodedCount = 0;
+    while (decoder.next(msg)) {
+        decodedCount++;
+        counters.received[static_cast<uint8_t>(msg.type)]++;
+        if (msg.type == MessageType::Spectrum) {
+            if (latestSpectrum >= 0) {
+                messages[latestSpectrum] = std::move(msg);
+                counters.spectrumCoalesced++;
+                continue;
+            }
+            latestSpectrum = static_cast<int>(messages.size());
+        }
+        messages.push_back(std::move(msg));
+    }
+    counters.unknownTypes = decoder.unknownTypes();
+    counters.maxMessagesPerPoll = std::max(counters.maxMessagesPerPoll, decodedCount);
+
+    if (decoder.failed()) {
+        counters.protocolErrors++;
+        closeReason = "protocol error";
+    }
+    if (closeReason) dropClient(closeReason);
+    return messages;
+}
+
+void MessageHandler::printStats(std::ostream& out) const {
+    out << "[MessageHandler] received";
+    for (uint8_t t = static_cast<uint8_t>(MessageType::Keyword);
+         t <= static_cast<uint8_t>(MessageType::Control); ++t) {
+        out << " " << messageTypeName(static_cast<MessageType>(t)) << "=" << counters.received[t];
+    }
+    out << " bytes=" << counters.bytesReceived << std::endl;
+    out << "[MessageHandler] spectrum_coalesced=" << counters.spectrumCoalesced
+        << " max_per_frame=" << counters.maxMessagesPerPoll
+        << " drain_limit_hits=" << counters.drainLimitHits
+        << " unknown_types=" << counters.unknownTypes
+        << " protocol_errors=" << counters.protocolErrors
+        << " connections=" << counters.connections
+        << " disconnects=" << counters.disconnects << std::endl;
+}
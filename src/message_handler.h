@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "latency_tracer.h"
+
+// Framed, typed IPC between the Python recognizer and the HUD over one
+// Unix domain stream socket. Every frame is
+//
+//   uint32 length   (little-endian, bytes that follow)
+//   uint8  type     (MessageType)
+//   int64  capture_ns, process_ns, sent_ns   (little-endian, CLOCK_MONOTONIC)
+//   payload         (UTF-8 text, or float32 LE array for spectrum)
+//
+// so messages arriving between frames are never merged or truncated.
+
+enum class MessageType : uint8_t {
+    Keyword = 1,
+    Partial = 2,
+    Final = 3,
+    Spectrum = 4,
+    Control = 5,
+};
+
+const char* messageTypeName(MessageType type);
+
+struct VisorMessage {
+    MessageType type;
+    LatencyTracer::Stamps stamps;
+    std::string text;             // keyword, partial, final, control
+    std::vector<float> spectrum;  // spectrum
+};
+
+// Incremental frame decoder; feed raw bytes, pull complete messages
+class MessageDecoder {
+public:
+    static constexpr size_t kHeaderSize = 4 + 1 + 3 * 8;
+    static constexpr uint32_t kMaxFrameLength = 64 * 1024;
+
+    void feed(const char* data, size_t len);
+
+    // Decode the next complete message; false if more bytes are needed or
+    // the stream is corrupt (check failed()). Unknown types are skipped.
+    bool next(VisorMessage& msg);
+
+    // Stream lost sync (bad length); the connection must be reset
+    bool failed() const { return corrupt; }
+    void reset();
+
+    uint64_t unknownTypes() const { return skippedUnknown; }
+    size_t buffered() const { return buffer.size() - offset; }
+
+private:
+    std::string buffer;
+    size_t offset = 0;
+    bool corrupt = false;
+    uint64_t skippedUnknown = 0;
+};
+
+// Owns the listening socket and the recognizer connection
+class MessageHandler {
+public:
+    struct Stats {
+        uint64_t received[6] = {0};  // indexed by MessageType
+        uint64_t bytesReceived = 0;
+        uint64_t spectrumCoalesced = 0;  // older spectra superseded within a frame
+        uint64_t unknownTypes = 0;
+        uint64_t protocolErrors = 0;
+        uint64_t connections = 0;
+        uint64_t disconnects = 0;
+        uint64_t drainLimitHits = 0;     // poll() stopped before the socket was empty
+        uint64_t maxMessagesPerPoll = 0;
+    };
+
+    explicit MessageHandler(const std::string& socketPath);
+    ~MessageHandler();
+
+    // Bind and listen; removes a stale socket file first
+    bool start();
+
+    // Accept a (re)connecting recognizer and drain every pending message.
+    // Only the newest spectrum is kept per call.
+    std::vector<VisorMessage> poll();
+
+    const Stats& stats() const { return counters; }
+    void printStats(std::ostream& out) const;
+
+private:
+    void acceptPending();
+    void dropClient(const char* reason);
+
+    std::string path;
+    int listenFd = -1;
+    int clientFd = -1;
+    MessageDecoder decoder;
+    Stats counters;
+};
@@ -0,0 +1,279 @@
+// Fuzz and throughput test for the recognizer -> HUD framing decoder.
+// Plain g++, no framework; see README for the build line (ASan/UBSan).
+#include "message_handler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+int failures = 0;
+
+void check(bool cond, const std::string& what) {
+    if (!cond) {
+        std::cerr << "[FAIL] " << what << std::endl;
+        failures++;
+    }
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out += static_cast<char>((v >> (8 * i)) & 0xff);
+}
+
+void putI64(std::string& out, int64_t v) {
+    for (int i = 0; i < 8; ++i) out += static_cast<char>((static_cast<uint64_t>(v) >> (8 * i)) & 0xff);
+}
+
+uint32_t readU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = (v << 8) | static_cast<unsigned char>(p[i]);
+    return v;
+}
+
+// Frame with an explicit length field, so tests can write invalid lengths
+std::string rawFrame(uint32_t length, uint8_t type, int64_t stamp, const std::string& payload) {
+    std::string out;
+    putU32(out, length);
+    out += static_cast<char>(type);
+    putI64(out, stamp);
+    putI64(out, stamp + 1);
+    putI64(out, stamp + 2);
+    out += payload;
+    return out;
+}
+
+std::string frame(uint8_t type, int64_t stamp, const std::string& payload) {
+    return rawFrame(static_cast<uint32_t>(MessageDecoder::kHeaderSize - 4 + payload.size()),
+                    type, stamp, payload);
+}
+
+std::string spectrumPayload(std::mt19937& rng, size_t count, std::vector<float>& values) {
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::string out;
+    values.clear();
+    for (size_t i = 0; i < count; ++i) {
+        float v = dist(rng);
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        putU32(out, bits);
+        values.push_back(v);
+    }
+    return out;
+}
+
+struct Expected {
+    MessageType type;
+    int64_t stamp;
+    std::string text;
+    std::vector<float> spectrum;
+};
+
+// Feed the stream in random-sized chunks and compare every decoded message
+void testRandomChunking(std::mt19937& rng) {
+    for (int iter = 0; iter < 2000; ++iter) {
+        std::string stream;
+        std::vector<Expected> expected;
+        int count = rng() % 60;
+        for (int i = 0; i < count; ++i) {
+            auto type = static_cast<MessageType>(1 + rng() % 5);
+            Expected e{type, 1000 + i, "", {}};
+            std::string payload;
+            if (type == MessageType::Spectrum) {
+                payload = spectrumPayload(rng, 64, e.spectrum);
+            } else {
+                payload.resize(rng() % 600);
+                for (auto& c : payload) c = static_cast<char>(rng());
+                e.text = payload;
+            }
+            stream += frame(static_cast<uint8_t>(type), e.stamp, payload);
+            expected.push_back(std::move(e));
+        }
+
+        MessageDecoder decoder;
+        VisorMessage msg;
+        size_t decoded = 0;
+        size_t pos = 0;
+        bool ok = true;
+        while (pos < stream.size()) {
+            size_t chunk = std::min<size_t>(1 + rng() % 257, stream.size() - pos);
+            decoder.feed(stream.data() + pos, chunk);
+            pos += chunk;
+            while (decoder.next(msg)) {
+                if (decoded >= expected.size()) {
+                    ok = false;
+                    break;
+                }
+                const Expected& e = expected[decoded++];
+                ok = ok && msg.type == e.type && msg.text == e.text && msg.spectrum == e.spectrum &&
+                     msg.stamps.captureNs == e.stamp && msg.stamps.processNs == e.stamp + 1 &&
+                     msg.stamps.sentNs == e.stamp + 2;
+            }
+        }
+        check(ok && decoded == expected.size(), "round trip of randomly chunked frames");
+        check(!decoder.failed() && decoder.buffered() == 0, "decoder idle after valid stream");
+    }
+}
+
+// Garbage must never overrun; a bad length must set failed() and stop decoding.
+// A decoder that has not failed may only hold back an incomplete frame whose
+// length field (at the start of the unconsumed suffix) is in range.
+void testGarbage(std::mt19937& rng) {
+    int failedStreams = 0;
+    for (int iter = 0; iter < 5000; ++iter) {
+        bool pureGarbage = iter % 10 == 0;
+        std::string stream;
+        if (pureGarbage) {
+            // Larger than one maximum frame, so holding it all back is a bug
+            stream.resize(4 + MessageDecoder::kMaxFrameLength + rng() % 65536);
+            for (auto& c : stream) c = static_cast<char>(rng());
+        } else {
+            // Valid frames with a few random byte flips
+            int count = 1 + rng() % 40;
+            for (int i = 0; i < count; ++i) {
+                std::string payload(rng() % 300, '\0');
+                for (auto& c : payload) c = static_cast<char>(rng());
+                stream += frame(static_cast<uint8_t>(1 + rng() % 5), i + 1, payload);
+            }
+            int flips = rng() % 8;
+            for (int i = 0; i < flips; ++i) stream[rng() % stream.size()] = static_cast<char>(rng());
+        }
+
+        MessageDecoder decoder;
+        VisorMessage msg;
+        size_t decoded = 0;
+        for (size_t pos = 0; pos < stream.size();) {
+            size_t chunk = std::min<size_t>(1 + rng() % 4096, stream.size() - pos);
+            decoder.feed(stream.data() + pos, chunk);
+            pos += chunk;
+            while (decoder.next(msg)) decoded++;
+        }
+        check(decoded * MessageDecoder::kHeaderSize <= stream.size(), "decoded no more frames than the bytes allow");
+
+        if (decoder.failed()) {
+            failedStreams++;
+            continue;
+        }
+        check(!pureGarbage, "garbage larger than a max frame sets failed()");
+        size_t rest = decoder.buffered();
+        if (rest >= 4) {
+            uint32_t length = readU32(stream.data() + stream.size() - rest);
+            check(length >= MessageDecoder::kHeaderSize - 4 && length <= MessageDecoder::kMaxFrameLength &&
+                  rest < 4 + static_cast<size_t>(length),
+                  "non-failed decoder holds back only an incomplete, in-range frame");
+        }
+    }
+    check(failedStreams > 0, "corrupted streams trip failed()");
+
+    for (int iter = 0; iter < 2000; ++iter) {
+        // Valid prefix, then a frame whose length is out of range
+        uint32_t badLength = (iter % 2) ? rng() % (MessageDecoder::kHeaderSize - 4)
+                                        : MessageDecoder::kMaxFrameLength + 1 + rng() % 100000;
+        std::string stream = frame(1, 1, "hello") + rawFrame(badLength, 1, 1, "");
+        std::string tail(rng() % 512, '\0');
+        for (auto& c : tail) c = static_cast<char>(rng());
+        stream += tail;
+
+        MessageDecoder decoder;
+        VisorMessage msg;
+        decoder.feed(stream.data(), stream.size());
+        check(decoder.next(msg) && msg.text == "hello", "valid prefix decodes before corruption");
+        check(!decoder.next(msg) && decoder.failed(), "bad length sets failed()");
+        decoder.feed(stream.data(), stream.size());
+        check(!decoder.next(msg), "failed decoder yields nothing more");
+        decoder.reset();
+        decoder.feed(stream.data(), stream.size());
+        check(decoder.next(msg) && !decoder.failed(), "reset decoder decodes again");
+    }
+}
+
+void testUnknownTypes() {
+    std::string stream = frame(1, 1, "hello") + frame(0, 1, "zero") + frame(42, 1, "future") +
+                         frame(255, 1, "") + frame(3, 1, "world");
+    MessageDecoder decoder;
+    VisorMessage msg;
+    decoder.feed(stream.data(), stream.size());
+    check(decoder.next(msg) && msg.type == MessageType::Keyword && msg.text == "hello", "keyword before unknown");
+    check(decoder.next(msg) && msg.type == MessageType::Final && msg.text == "world", "unknown types skipped");
+    check(!decoder.next(msg) && !decoder.failed(), "stream ends cleanly");
+    check(decoder.unknownTypes() == 3, "unknown types counted");
+}
+
+void testBoundaryLengths() {
+    const uint32_t minLength = MessageDecoder::kHeaderSize - 4;  // 25: empty payload
+    check(minLength == 25, "header is 25 bytes after the length field");
+
+    MessageDecoder decoder;
+    VisorMessage msg;
+    std::string stream = rawFrame(minLength, 2, 7, "");
+    decoder.feed(stream.data(), stream.size());
+    check(decoder.next(msg) && msg.type == MessageType::Partial && msg.text.empty() &&
+          msg.stamps.captureNs == 7, "length 25 decodes as an empty payload");
+
+    decoder.reset();
+    stream = rawFrame(minLength - 1, 2, 7, "");
+    decoder.feed(stream.data(), stream.size());
+    check(!decoder.next(msg) && decoder.failed(), "length 24 is rejected");
+
+    decoder.reset();
+    std::string payload(MessageDecoder::kMaxFrameLength - minLength, 'x');
+    stream = rawFrame(MessageDecoder::kMaxFrameLength, 3, 7, payload);
+    decoder.feed(stream.data(), stream.size() - 1);
+    check(!decoder.next(msg) && !decoder.failed(), "max-length frame waits for its last byte");
+    decoder.feed(stream.data() + stream.size() - 1, 1);
+    check(decoder.next(msg) && msg.text == payload, "kMaxFrameLength decodes");
+
+    decoder.reset();
+    stream = rawFrame(MessageDecoder::kMaxFrameLength + 1, 3, 7, payload + "x");
+    decoder.feed(stream.data(), stream.size());
+    check(!decoder.next(msg) && decoder.failed(), "kMaxFrameLength + 1 is rejected");
+}
+
+// Typical per-frame mix, fed in socket-sized reads
+void testThroughput(std::mt19937& rng) {
+    std::string stream;
+    std::vector<float> values;
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 4 == 0) {
+            stream += frame(4, i + 1, spectrumPayload(rng, 64, values));
+        } else {
+            stream += frame(1 + i % 3, i + 1, std::string(40, 'x'));
+        }
+    }
+
+    MessageDecoder decoder;
+    VisorMessage msg;
+    size_t count = 0;
+    const int rounds = 500;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t pos = 0; pos < stream.size(); pos += 4096) {
+            decoder.feed(stream.data() + pos, std::min<size_t>(4096, stream.size() - pos));
+            while (decoder.next(msg)) count++;
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    check(count == 1000u * rounds, "throughput stream fully decoded");
+    std::cout << "[MessageDecoderTest] throughput: " << static_cast<uint64_t>(count / secs)
+              << " msgs/s, " << static_cast<uint64_t>(stream.size() * rounds / secs / 1e6) << " MB/s"
+              << std::endl;
+}
+}
+
+int main() {
+    std::mt19937 rng(0x5eed);
+    testRandomChunking(rng);
+    testGarbage(rng);
+    testUnknownTypes();
+    testBoundaryLengths();
+    testThroughput(rng);
+
+    if (failures > 0) {
+        std::cerr << "[MessageDecoderTest] " << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[MessageDecoderTest] all checks passed" << std::endl;
+    return 0;
+}